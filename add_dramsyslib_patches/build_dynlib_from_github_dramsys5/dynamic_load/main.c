@@ -8,6 +8,27 @@ uint64_t rec[64] = {0,0,0,0,0};
 
 #define TXN_LEN 64
 
+// Functions the patch exports, a library built before the current patch lacks some of them
+const char * bridge_functions[] = {
+    "add_dram", "dram_config_load", "add_dram_from_config", "add_dram_backend", "add_dram_ports",
+    "add_dram_system", "dram_can_accept_req", "dram_has_read_rsp", "dram_has_write_rsp",
+    "dram_get_write_rsp", "dram_write_buffer", "dram_write_strobe", "dram_send_req",
+    "dram_can_accept_timed_req", "dram_set_timed_window", "dram_send_req_timed",
+    "dram_get_timing_error", "dram_get_read_rsp", "dram_get_read_rsp_byte", "run_ns",
+    "dram_get_time_ps", "run_until_ps", "dram_get_inflight_read", "dram_start_thread", "dram_post_req",
+    "dram_poll_rsp", "dram_quantum_barrier", "dram_stop_thread", "dram_set_functional",
+    "dram_set_functional_latency", "dram_set_roi_addr", "dram_roi_report", "dram_enable_sampling",
+    "dram_sampling_report", "dram_profile_report", "dram_stats_geometry", "dram_stats_counters",
+    "dram_stats_latency", "dram_stats_bandwidth", "dram_stats_reset", "dram_stats_dump",
+    "dram_capture_parse_line", "dram_storage_reserved", "dram_storage_resident", "close_dram",
+    "dram_decode_channel", "dram_backdoor_write", "dram_backdoor_read", "dram_hash_range",
+    "dram_compare_range", "dram_compare_file", "dram_channel_pointers", "dram_preload_byte",
+    "dram_check_byte", "dram_load_elf", "dram_elf_symbol", "dram_elf_entry", "dram_load_file",
+    "dram_load_memfile", "dram_load_image", "dram_dump_image", "dram_checkpoint", "dram_restore",
+    "dram_register_async_callback", "dram_toggle_pim", "dram_register_pim_callback", "dram_pim_read",
+    "dram_pim_write", "dram_serve", NULL
+};
+
 void print_data(uint64_t * buf){
     int i;
     for (i = 0; i < 10; ++i)
@@ -18,6 +39,7 @@ void print_data(uint64_t * buf){
 }
 
 int main() {
+    int i;
     void* libraryHandle;
     int (*add_dram)(char *, char *);
     void (*close_dram)(int);
@@ -32,6 +54,23 @@ int main() {
     printf("load library --- \n");
     libraryHandle = dlopen("third_party/DRAMSys/libDRAMSys_Simulator.so", RTLD_LAZY);
 
+    if (libraryHandle == NULL)
+    {
+        printf("can not load the library: %s\n", dlerror());
+        return 1;
+    }
+
+    printf("check library version --- \n");
+    for (i = 0; bridge_functions[i] != NULL; ++i)
+    {
+        if (dlsym(libraryHandle, bridge_functions[i]) == NULL)
+        {
+            printf("the library does not export %s, it was built from an older patch\n", bridge_functions[i]);
+            dlclose(libraryHandle);
+            return 1;
+        }
+    }
+
     printf("get function --- \n");
     add_dram = dlsym(libraryHandle, "add_dram");
     close_dram = dlsym(libraryHandle, "close_dram");
@@ -0,0 +1,1362 @@
+#define _GNU_SOURCE  // memmem
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <dlfcn.h>  // Linux specific header for dynamic loading
+
+// Tests of the bridge extensions of the patched library, run from the repository root:
+//   gcc tests.c -ldl -o tests && ./tests [library [client library]]
+// The library defaults to third_party/DRAMSys/libDRAMSys_Simulator.so, the client library to
+// libDRAMSys_Client.so next to it. SystemC can not elaborate modules once it has started, every DRAM
+// is therefore added before the first run_ns, and servers are forked before any DRAM is added.
+
+#define CONFIG_DIR  "add_dramsyslib_patches/dramsys_configs"
+#define HBM2_CONFIG CONFIG_DIR "/hbm2-example.json"
+#define WIDEIO_CONFIG CONFIG_DIR "/wideio-example.json"
+
+#define DRAM_FILE_READMEMH  1
+#define DRAM_FILE_IHEX      2
+
+#define DRAM_BACKEND_ANALYTICAL 1
+
+// Traffic statistics, as declared in dramsys_stats.h
+#define DRAM_STATS_NB_COUNTERS  7
+#define DRAM_STATS_NB_BUCKETS   24
+
+// RISC-V test binary of the repository: PT_LOAD segments at physical 0x1c000004 (file 0x1004, with
+// .bss from 0x1c001510 to 0x1c001d44) and 0x1c008000 (.text, file 0x3000), entry _start
+#define ELF_PATH    "add_dramsyslib_patches/dma_dram_test.bin"
+#define ELF_BASE    0x1c000000
+
+// Geometry returned by add_dram, as declared in Simulator.h
+typedef struct {
+    unsigned int access_size;
+    unsigned int nb_channels;
+    unsigned int nb_pseudo_channels;
+    unsigned int nb_ranks;
+    unsigned int nb_bank_groups;
+    unsigned int nb_banks;
+    unsigned int nb_rows;
+    unsigned int nb_columns;
+    unsigned int channel_stride;
+    unsigned int rank_stride;
+    unsigned int bankgroup_stride;
+    unsigned int bank_stride;
+    unsigned int row_stride;
+    unsigned int column_stride;
+} GvsocMemspec;
+
+// Transaction log of DRAMSYS_RECORD, as declared in dramsys_recorder.h
+typedef struct {
+    uint64_t addr;
+    uint64_t arrival_ps;
+    uint64_t begin_req_ps;
+    uint64_t end_req_ps;
+    uint64_t begin_resp_ps;
+    uint32_t length;
+    uint8_t is_write;
+    uint8_t functional;
+    uint8_t reserved[18];
+} DramRecord;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    int64_t dram_id;
+} DramRecordHeader;
+
+void * libraryHandle;
+void * clientHandle;
+int failures = 0;
+char scratch_dir[] = "/tmp/dramsys_testsXXXXXX";
+char scratch_path[256];
+
+int (*add_dram)(char *, char *, void *);
+int (*add_dram_backend)(char *, char *, GvsocMemspec *, int backend);
+int (*dram_config_load)(char * resources_path, char * simulationJson_path);
+int (*add_dram_from_config)(int config_handle, GvsocMemspec * memspec);
+int (*add_dram_ports)(char *, char *, GvsocMemspec *, int nb_ports);
+int (*add_dram_system)(char *, char *, void *, uint64_t granularity, int xor_hash);
+void (*close_dram)(int);
+void (*run_ns)(int ns);
+int (*dram_can_accept_req)(int dram_id);
+void (*dram_send_req)(int dram_id, uint64_t addr, uint64_t length, uint64_t is_write, uint64_t strob_enable);
+int (*dram_has_read_rsp)(int dram_id);
+void (*dram_get_read_rsp)(int dram_id, uint64_t length, const void * buf);
+int (*dram_has_write_rsp)(int dram_id);
+int (*dram_get_write_rsp)(int dram_id);
+void (*dram_backdoor_write)(int dram_id, uint64_t addr, const void * data, uint64_t len);
+void (*dram_backdoor_read)(int dram_id, uint64_t addr, void * data, uint64_t len);
+uint64_t (*dram_hash_range)(int dram_id, uint64_t addr, uint64_t len);
+uint64_t (*dram_compare_range)(int dram_id, uint64_t addr, uint64_t len, const void * golden, int max_report);
+int64_t (*dram_load_file)(int dram_id, uint64_t addr_ofst, char * path, int format, int word_bytes);
+int (*dram_channel_pointers)(int dram_id, unsigned char ** pointers, uint64_t * sizes, int max);
+unsigned (*dram_decode_channel)(int dram_id, uint64_t addr);
+int (*dram_checkpoint)(int dram_id, char * path);
+int (*dram_restore)(int dram_id, char * path);
+void (*dram_load_elf)(int dram_id, uint64_t dram_base_addr, char * elf_path);
+int (*dram_elf_symbol)(char * name, uint64_t * value);
+uint64_t (*dram_elf_entry)(void);
+void (*dram_dump_image)(int dram_id, char * image_path, uint64_t size);
+void (*dram_load_image)(int dram_id, char * image_path);
+uint64_t (*dram_storage_reserved)(int dram_id);
+uint64_t (*dram_storage_resident)(int dram_id);
+void (*dram_set_timed_window)(int dram_id, int max_req);
+int (*dram_can_accept_timed_req)(int dram_id);
+void (*dram_send_req_timed)(int dram_id, uint64_t addr, uint64_t length, uint64_t is_write, uint64_t strob_enable, uint64_t timestamp_ps);
+void (*dram_get_timing_error)(int dram_id, uint64_t * late_req, uint64_t * max_lateness_ps);
+uint64_t (*dram_get_time_ps)(void);
+void (*run_until_ps)(uint64_t time_ps);
+int (*dram_get_inflight_read)(int dram_id);
+void (*dram_write_buffer)(int dram_id, int byte_int, int idx);
+void (*dram_enable_sampling)(int dram_id, uint64_t ff_req, uint64_t warmup_req, uint64_t detail_req);
+void (*dram_sampling_report)(int dram_id);
+void (*dram_set_functional)(int dram_id, int functional);
+void (*dram_set_functional_latency)(int dram_id, uint64_t latency_ps);
+void (*dram_set_roi_addr)(int dram_id, uint64_t addr);
+void (*dram_roi_report)(int dram_id);
+void (*dram_start_thread)(void);
+int (*dram_post_req)(int dram_id, uint64_t tag, uint64_t addr, uint64_t length, uint64_t is_write, uint64_t strob_enable, const void * data, const void * strobe, uint64_t timestamp_ps);
+int (*dram_poll_rsp)(int dram_id, uint64_t * tag, uint64_t * is_write, void * data, uint64_t * time_ps);
+void (*dram_quantum_barrier)(uint64_t time_ps);
+void (*dram_stop_thread)(void);
+int (*dram_serve)(const char * shm_name);
+int (*dram_stats_geometry)(int dram_id, unsigned * nb_channels, unsigned * nb_banks);
+void (*dram_stats_counters)(int dram_id, int channel, int bank, uint64_t * values);
+int (*dram_stats_latency)(int dram_id, int service, uint64_t * buckets);
+int (*dram_stats_bandwidth)(int dram_id, uint64_t * read_bytes, uint64_t * write_bytes, int max, uint64_t * window_ps);
+void (*dram_stats_reset)(int dram_id);
+int (*dram_stats_dump)(int dram_id, char * path);
+void (*dram_profile_report)(void);
+int (*dram_capture_parse_line)(const char * line, uint64_t default_length, uint64_t * cycle, uint64_t * length, int * is_write, uint64_t * addr);
+
+// Bridge functions of the client library, forwarded to the forked servers
+struct {
+    int (*add_dram)(char *, char *, GvsocMemspec *);
+    void (*close_dram)(int);
+    void (*run_ns)(int ns);
+    int (*dram_can_accept_req)(int dram_id);
+    void (*dram_send_req)(int dram_id, uint64_t addr, uint64_t length, uint64_t is_write, uint64_t strob_enable);
+    void (*dram_write_buffer)(int dram_id, int byte_int, int idx);
+    int (*dram_has_read_rsp)(int dram_id);
+    void (*dram_get_read_rsp)(int dram_id, uint64_t length, const void * buf);
+    int (*dram_has_write_rsp)(int dram_id);
+    int (*dram_get_write_rsp)(int dram_id);
+    void (*dram_backdoor_write)(int dram_id, uint64_t addr, const void * data, uint64_t len);
+    void (*dram_backdoor_read)(int dram_id, uint64_t addr, void * data, uint64_t len);
+    uint64_t (*dram_hash_range)(int dram_id, uint64_t addr, uint64_t len);
+    int (*dram_channel_pointers)(int dram_id, unsigned char ** pointers, uint64_t * sizes, int max);
+    void (*dram_shutdown_server)(void);
+} client;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { printf("FAIL %s:%d: ", __func__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+    } while (0)
+
+void * get_function(const char * name) {
+    void * function = dlsym(libraryHandle, name);
+    if (function == NULL)
+    {
+        // the prebuilt library predates the bridge extensions
+        printf("missing function %s, rebuild the library from the patch\n", name);
+        exit(1);
+    }
+    return function;
+}
+
+void * get_client_function(const char * name) {
+    void * function = dlsym(clientHandle, name);
+    if (function == NULL)
+    {
+        printf("missing function %s in the client library, rebuild it from the patch\n", name);
+        exit(1);
+    }
+    return function;
+}
+
+// Writes a file of the scratch directory, returns its path
+char * write_file(const char * name, const char * content) {
+    snprintf(scratch_path, sizeof(scratch_path), "%s/%s", scratch_dir, name);
+    FILE * file = fopen(scratch_path, "w");
+    fputs(content, file);
+    fclose(file);
+    return scratch_path;
+}
+
+// XXH64 of DRAM ranges, reference values of xxhsum -H1
+void test_hash(int dram_id) {
+    static const struct { const char * data; uint64_t hash; } vectors[] = {
+        {"",                                        0xEF46DB3751D8E999ull},
+        {"a",                                       0xD24EC4F1A98C6E5Bull},
+        {"abc",                                     0x44BC2CF5AD770999ull},
+        {"xxhash",                                  0x32DD38952C4BC720ull},
+        {"Nobody inspects the spammish repetition", 0xFBCEA83C8A378BF1ull},
+    };
+    size_t i;
+    for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); ++i)
+    {
+        uint64_t addr = 0x1000 * (i + 1) + 3;
+        dram_backdoor_write(dram_id, addr, vectors[i].data, strlen(vectors[i].data));
+        uint64_t hash = dram_hash_range(dram_id, addr, strlen(vectors[i].data));
+        CHECK(hash == vectors[i].hash, "\"%s\": %016llx", vectors[i].data, (unsigned long long)hash);
+    }
+
+    // several 32-byte stripes and a tail, across interleaving and channel boundaries
+    uint8_t pattern[1000];
+    for (i = 0; i < sizeof(pattern); ++i) pattern[i] = i * 7 + 3;
+    dram_backdoor_write(dram_id, 0x10000 - 100, pattern, sizeof(pattern));
+    uint64_t hash = dram_hash_range(dram_id, 0x10000 - 100, sizeof(pattern));
+    CHECK(hash == 0x5F235FA033F1A3FBull, "pattern: %016llx", (unsigned long long)hash);
+
+    CHECK(dram_compare_range(dram_id, 0x10000 - 100, sizeof(pattern), pattern, 0) == 0, "pattern does not compare equal");
+    pattern[500] ^= 0xff;
+    CHECK(dram_compare_range(dram_id, 0x10000 - 100, sizeof(pattern), pattern, 0) == 1, "modified byte not reported");
+}
+
+// $readmemh words and Intel HEX records, compared byte for byte
+void test_load_file(int dram_id) {
+    uint8_t data[8];
+    char * path = write_file("words.hex",
+        "// 32-bit words, stored little-endian\n"
+        "/* word address jumps\n"
+        "   and separators */\n"
+        "@4\n"
+        "0123_4567 89abcdef\n"
+        "@10 deadbeef // last word\n");
+    int64_t loaded = dram_load_file(dram_id, 0x20000, path, DRAM_FILE_READMEMH, 4);
+    CHECK(loaded == 12, "readmemh loaded %lld bytes", (long long)loaded);
+    static const uint8_t words[8] = {0x67, 0x45, 0x23, 0x01, 0xef, 0xcd, 0xab, 0x89};
+    dram_backdoor_read(dram_id, 0x20000 + 0x10, data, 8);
+    CHECK(memcmp(data, words, 8) == 0, "readmemh words at @4");
+    static const uint8_t last[4] = {0xef, 0xbe, 0xad, 0xde};
+    dram_backdoor_read(dram_id, 0x20000 + 0x40, data, 4);
+    CHECK(memcmp(data, last, 4) == 0, "readmemh word at @10");
+    unlink(path);
+
+    // extended linear address 0x0001, two consecutive data records
+    path = write_file("image.ihex",
+        ":020000040001F9\n"
+        ":04001000DEADBEEFB4\n"
+        ":020014000102E7\n"
+        ":00000001FF\n");
+    loaded = dram_load_file(dram_id, 0x30000, path, DRAM_FILE_IHEX, 0);
+    CHECK(loaded == 6, "ihex loaded %lld bytes", (long long)loaded);
+    static const uint8_t bytes[6] = {0xde, 0xad, 0xbe, 0xef, 0x01, 0x02};
+    dram_backdoor_read(dram_id, 0x30000 + 0x10010, data, 6);
+    CHECK(memcmp(data, bytes, 6) == 0, "ihex data at 0x10010");
+    unlink(path);
+
+    path = write_file("corrupted.ihex", ":04001000DEADBEEFB5\n:00000001FF\n");
+    CHECK(dram_load_file(dram_id, 0x30000, path, DRAM_FILE_IHEX, 0) == -1, "ihex checksum error not reported");
+    unlink(path);
+
+    // malformed files are rejected before anything is written, even after valid data
+    static const uint8_t fill[4] = {0x55, 0x55, 0x55, 0x55};
+    dram_backdoor_write(dram_id, 0x38000, fill, 4);
+    path = write_file("address.ihex", ":040000001122334452\n:03000004000100F8\n:00000001FF\n");
+    CHECK(dram_load_file(dram_id, 0x38000, path, DRAM_FILE_IHEX, 0) == -1, "ihex address record of 3 bytes not reported");
+    unlink(path);
+    path = write_file("wide.hex", "01234567\n123456789\n");
+    CHECK(dram_load_file(dram_id, 0x38000, path, DRAM_FILE_READMEMH, 4) == -1, "readmemh word wider than 4 bytes not reported");
+    unlink(path);
+    path = write_file("invalid.hex", "01234567\n@100\n0123456g\n");
+    CHECK(dram_load_file(dram_id, 0x38000, path, DRAM_FILE_READMEMH, 4) == -1, "readmemh invalid digit not reported");
+    unlink(path);
+    dram_backdoor_read(dram_id, 0x38000, data, 4);
+    CHECK(memcmp(data, fill, 4) == 0, "malformed file partially written");
+}
+
+// Reference routing of the interleaved memory system
+unsigned target_of(uint64_t addr, unsigned nb_targets, uint64_t granularity, int xor_hash) {
+    uint64_t block = addr / granularity;
+    unsigned target_bits = 0;
+    unsigned target = 0;
+    if (!xor_hash || nb_targets == 1) return block % nb_targets;
+    while ((1u << target_bits) < nb_targets) target_bits++;
+    for (; block != 0; block >>= target_bits) target ^= block & (nb_targets - 1);
+    return target;
+}
+
+uint64_t local_addr_of(uint64_t addr, unsigned nb_targets, uint64_t granularity) {
+    return (addr / granularity / nb_targets) * granularity + addr % granularity;
+}
+
+// Every address of a range holds its own word, so no two addresses share a location, and the words
+// are found at the routed location in the storage of single channel instances
+void test_system(int dram_id, unsigned nb_targets, uint64_t granularity, int xor_hash) {
+    static uint64_t words[8192];
+    unsigned char * pointers[8];
+    uint64_t sizes[8];
+    uint64_t i;
+    for (i = 0; i < 8192; ++i)
+    {
+        uint64_t word = 0x5a5a000000000000ull | (i * 8);
+        dram_backdoor_write(dram_id, i * 8, &word, 8);
+    }
+    dram_backdoor_read(dram_id, 0, words, sizeof(words));
+    for (i = 0; i < 8192; ++i)
+    {
+        CHECK(words[i] == (0x5a5a000000000000ull | (i * 8)), "%u instances, xor %d: word at 0x%llx reads %llx",
+            nb_targets, xor_hash, (unsigned long long)(i * 8), (unsigned long long)words[i]);
+    }
+
+    if (dram_channel_pointers(dram_id, pointers, sizes, 8) != (int)nb_targets) return;
+    for (i = 0; i < 8192; i += granularity / 8)
+    {
+        uint64_t word;
+        unsigned target = target_of(i * 8, nb_targets, granularity, xor_hash);
+        uint64_t local = local_addr_of(i * 8, nb_targets, granularity);
+        memcpy(&word, pointers[target] + local, 8);
+        CHECK(word == (0x5a5a000000000000ull | (i * 8)), "%u instances, xor %d: 0x%llx not at 0x%llx of instance %u",
+            nb_targets, xor_hash, (unsigned long long)(i * 8), (unsigned long long)local, target);
+    }
+}
+
+// The storage of a fresh DRAM reserves the whole memory as address space, untouched pages read as
+// zero, and writes to 16 pages spread over 16 MB make about as many pages resident
+void test_storage_footprint(int dram_id, GvsocMemspec * memspec) {
+    uint8_t data[64], zeros[64] = {0}, byte = 0x42;
+    uint64_t reserved = dram_storage_reserved(dram_id);
+    uint64_t resident_before = dram_storage_resident(dram_id), resident;
+    int k;
+    CHECK(reserved == (uint64_t)memspec->nb_rows * memspec->row_stride, "%llu bytes reserved", (unsigned long long)reserved);
+    CHECK(resident_before <= (2 << 20), "%llu bytes resident in a fresh DRAM", (unsigned long long)resident_before);
+
+    dram_backdoor_read(dram_id, 0x4000000, data, 64);
+    CHECK(memcmp(data, zeros, 64) == 0, "untouched storage not zero");
+    for (k = 0; k < 16; ++k) dram_backdoor_write(dram_id, (uint64_t)k << 20 | 0x123, &byte, 1);
+    resident = dram_storage_resident(dram_id);
+    CHECK(resident - resident_before >= 16 * 4096 && resident - resident_before <= 17 * (2 << 20) && resident <= reserved,
+        "16 written pages took %llu resident bytes", (unsigned long long)(resident - resident_before));
+}
+
+// Whether the VmFlags of the mapping containing addr in /proc/self/smaps list flag
+int mapping_has_flag(const void * addr, const char * flag) {
+    FILE * file = fopen("/proc/self/smaps", "r");
+    char line[512], * token;
+    unsigned long start, end;
+    int inside = 0, found = 0;
+    while (file != NULL && fgets(line, sizeof(line), file))
+    {
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) inside = (uintptr_t)addr >= start && (uintptr_t)addr < end;
+        else if (inside && strncmp(line, "VmFlags:", 8) == 0)
+        {
+            for (token = strtok(line + 8, " \n"); token != NULL; token = strtok(NULL, " \n")) found |= strcmp(token, flag) == 0;
+        }
+    }
+    if (file != NULL) fclose(file);
+    return found;
+}
+
+// Policy of the mapping containing addr in /proc/self/numa_maps, returns 0 without NUMA support
+int mapping_numa_policy(const void * addr, char * policy, size_t size) {
+    FILE * file = fopen("/proc/self/numa_maps", "r");
+    char line[512], name[64];
+    unsigned long start, best = 0;
+    if (file == NULL) return 0;
+    policy[0] = 0;
+    while (fgets(line, sizeof(line), file))
+    {
+        if (sscanf(line, "%lx %63s", &start, name) == 2 && start <= (uintptr_t)addr && start >= best)
+        {
+            best = start;
+            snprintf(policy, size, "%s", name);
+        }
+    }
+    fclose(file);
+    return 1;
+}
+
+// The simconfig policy of the DRAM added from policy.json, transparent huge pages on the local node,
+// is applied to its storage mapping, and not to the storage of a DRAM without policy
+void test_storage_policy(int dram_id, int default_id) {
+    unsigned char * pointers[4];
+    uint64_t sizes[4];
+    uint8_t byte = 0x24;
+    char policy[64];
+    dram_backdoor_write(dram_id, 0x100000, &byte, 1);
+    CHECK(dram_channel_pointers(dram_id, pointers, sizes, 4) == 1, "HBM2 storage not in one region");
+    CHECK(mapping_has_flag(pointers[0], "hg"), "storage not advised for transparent huge pages");
+    if (mapping_numa_policy(pointers[0], policy, sizeof(policy)))
+    {
+        CHECK(strncmp(policy, "prefer:", 7) == 0, "NUMA policy of the storage is %s", policy);
+    }
+
+    dram_channel_pointers(default_id, pointers, sizes, 4);
+    CHECK(!mapping_has_flag(pointers[0], "hg"), "storage without policy advised for transparent huge pages");
+
+    snprintf(scratch_path, sizeof(scratch_path), "%s/policy.json", scratch_dir);
+    unlink(scratch_path);
+    snprintf(scratch_path, sizeof(scratch_path), "%s/policy_simconfig.json", scratch_dir);
+    unlink(scratch_path);
+}
+
+// Contents written after a checkpoint are undone by the restore, zeros included
+void test_checkpoint(int dram_id) {
+    uint8_t pattern[5000];
+    uint8_t data[5000];
+    uint64_t i;
+    for (i = 0; i < sizeof(pattern); ++i) pattern[i] = i * 13 + 1;
+    dram_backdoor_write(dram_id, 0x40000 + 123, pattern, sizeof(pattern));
+
+    char checkpoint[256];
+    snprintf(checkpoint, sizeof(checkpoint), "%s/dram.ckpt", scratch_dir);
+    CHECK(dram_checkpoint(dram_id, checkpoint) == 0, "checkpoint failed");
+
+    memset(data, 0xee, sizeof(data));
+    dram_backdoor_write(dram_id, 0x40000 + 123, data, sizeof(data));
+    dram_backdoor_write(dram_id, 0x80000, data, sizeof(data));
+    CHECK(dram_restore(dram_id, checkpoint) == 0, "restore failed");
+
+    dram_backdoor_read(dram_id, 0x40000 + 123, data, sizeof(data));
+    CHECK(memcmp(data, pattern, sizeof(pattern)) == 0, "pattern not restored");
+    dram_backdoor_read(dram_id, 0x80000, data, sizeof(data));
+    for (i = 0; i < sizeof(data) && data[i] == 0; ++i);
+    CHECK(i == sizeof(data), "page written after the checkpoint not cleared");
+    unlink(checkpoint);
+
+    char * path = write_file("garbage.ckpt", "DRAMCKPT and then anything but a checkpoint");
+    CHECK(dram_restore(dram_id, path) == -1, "garbage checkpoint accepted");
+    dram_backdoor_read(dram_id, 0x40000 + 123, data, sizeof(data));
+    CHECK(memcmp(data, pattern, sizeof(pattern)) == 0, "rejected checkpoint changed the contents");
+    unlink(path);
+}
+
+// Runs until len bytes of read responses are queued, returns 0 on timeout
+int wait_read_rsp(int dram_id, int len) {
+    int i;
+    for (i = 0; dram_has_read_rsp(dram_id) < len && i < 10000; ++i) run_until_ps(dram_get_time_ps() + 1000);
+    return dram_has_read_rsp(dram_id) >= len;
+}
+
+// Timestamped requests are injected when SystemC reaches their stamp, in stamp order and not in call
+// order, and requests stamped in the past are accounted as timing error
+void test_timed(int dram_id) {
+    uint8_t first[64], second[64], data[64];
+    uint64_t late_before, late, lateness_before, lateness;
+    int i;
+    for (i = 0; i < 64; ++i)
+    {
+        first[i] = 0xa0 + i;
+        second[i] = 0x30 + i;
+    }
+    dram_backdoor_write(dram_id, 0x50000, second, 64);
+    dram_backdoor_write(dram_id, 0x51000, first, 64);
+    dram_get_timing_error(dram_id, &late_before, &lateness_before);
+
+    uint64_t now = dram_get_time_ps();
+    dram_set_timed_window(dram_id, 2);
+    dram_send_req_timed(dram_id, 0x50000, 64, 0, 0, now + 20000);
+    dram_send_req_timed(dram_id, 0x51000, 64, 0, 0, now + 10000);
+    CHECK(!dram_can_accept_timed_req(dram_id), "window of 2 timed requests not enforced");
+    dram_set_timed_window(dram_id, 64);
+
+    run_until_ps(now + 9000);
+    CHECK(dram_get_time_ps() == now + 9000, "run_until_ps stopped at %llu ps", (unsigned long long)(dram_get_time_ps() - now));
+    CHECK(dram_get_inflight_read(dram_id) == 0 && dram_has_read_rsp(dram_id) == 0, "request injected before its timestamp");
+    CHECK(wait_read_rsp(dram_id, 128), "timed reads not answered");
+    dram_get_read_rsp(dram_id, 64, data);
+    CHECK(memcmp(data, first, 64) == 0, "read stamped first not answered first");
+    dram_get_read_rsp(dram_id, 64, data);
+    CHECK(memcmp(data, second, 64) == 0, "read stamped second not answered second");
+
+    now = dram_get_time_ps();
+    dram_send_req_timed(dram_id, 0x51000, 64, 0, 0, now - 3000);
+    dram_get_timing_error(dram_id, &late, &lateness);
+    CHECK(late == late_before + 1 && lateness >= 3000, "late request accounted as %llu late, %llu ps",
+        (unsigned long long)(late - late_before), (unsigned long long)lateness);
+    CHECK(wait_read_rsp(dram_id, 64), "late read not answered");
+    dram_get_read_rsp(dram_id, 64, data);
+    CHECK(memcmp(data, first, 64) == 0, "late read data");
+}
+
+// Sends an untimed request and runs until its response, returns its latency in ps. Read data is copied
+// to data, write data is taken from it.
+uint64_t blocking_access(int dram_id, uint64_t addr, int is_write, uint8_t * data) {
+    uint64_t start = dram_get_time_ps();
+    int i;
+    for (i = 0; is_write && i < 64; ++i) dram_write_buffer(dram_id, data[i], i);
+    dram_send_req(dram_id, addr, 64, is_write, 0);
+    for (i = 0; (is_write ? !dram_has_write_rsp(dram_id) : dram_has_read_rsp(dram_id) < 64) && i < 10000; ++i) run_ns(1);
+    if (is_write) dram_get_write_rsp(dram_id);
+    else dram_get_read_rsp(dram_id, 64, data);
+    return dram_get_time_ps() - start;
+}
+
+// Two ports of add_dram_ports on one DRAMSys instance: they take consecutive ids, reads sent on both
+// ports in the same cycle are arbitrated by DRAMSys and answered to the port that sent them, and
+// both ports reach the same memory
+void test_ports(int port_id, int next_id) {
+    uint8_t pattern[2][4][64], line[64], data[64];
+    int i, k, p;
+    CHECK(next_id == port_id + 2, "DRAM added after 2 ports has id %d, the ports start at %d", next_id, port_id);
+    for (p = 0; p < 2; ++p)
+    {
+        for (k = 0; k < 4; ++k)
+        {
+            for (i = 0; i < 64; ++i) pattern[p][k][i] = 0x80 * p + 16 * k + i;
+            dram_backdoor_write(port_id + 1 - p, 0xb0000 + 0x1000 * p + 64 * k, pattern[p][k], 64);
+        }
+    }
+
+    for (k = 0; k < 4; ++k)
+    {
+        for (p = 0; p < 2; ++p)
+        {
+            CHECK(dram_can_accept_req(port_id + p), "port %d refused read %d", p, k);
+            dram_send_req(port_id + p, 0xb0000 + 0x1000 * p + 64 * k, 64, 0, 0);
+        }
+    }
+    for (i = 0; (dram_has_read_rsp(port_id) < 256 || dram_has_read_rsp(port_id + 1) < 256) && i < 10000; ++i) run_ns(1);
+    for (p = 0; p < 2; ++p)
+    {
+        CHECK(dram_has_read_rsp(port_id + p) == 256, "port %d has %d bytes of read responses", p, dram_has_read_rsp(port_id + p));
+        for (k = 0; k < 4; ++k)
+        {
+            dram_get_read_rsp(port_id + p, 64, data);
+            CHECK(memcmp(data, pattern[p][k], 64) == 0, "read %d of port %d", k, p);
+        }
+    }
+
+    for (i = 0; i < 64; ++i) line[i] = 0x3c ^ i;
+    blocking_access(port_id + 1, 0xb2000, 1, line);
+    CHECK(dram_has_write_rsp(port_id) == 0, "write response of port 1 given to port 0");
+    blocking_access(port_id, 0xb2000, 0, data);
+    CHECK(memcmp(data, line, 64) == 0, "write request of port 1 not seen by a read of port 0");
+}
+
+// Whether the mapping containing addr in /proc/self/maps is the file path
+int mapping_is_file(const void * addr, const char * path) {
+    FILE * file = fopen("/proc/self/maps", "r");
+    char line[512], name[256];
+    unsigned long start, end;
+    int found = 0;
+    while (file != NULL && fgets(line, sizeof(line), file))
+    {
+        if (sscanf(line, "%lx-%lx %*s %*s %*s %*s %255s", &start, &end, name) == 3 && (uintptr_t)addr >= start && (uintptr_t)addr < end)
+        {
+            found = strcmp(name, path) == 0;
+        }
+    }
+    if (file != NULL) fclose(file);
+    return found;
+}
+
+// A 4 MB image dumped from a DRAM is sparse and has its contents, it is mapped over the storage of a
+// single-channel DRAM, which sees it through requests, and writes to the DRAM do not reach the file
+void test_image(int dram_id, int image_id) {
+    uint8_t pattern[64], line[64], data[64];
+    unsigned char * pointers[1];
+    uint64_t sizes[1];
+    struct stat st;
+    int i;
+    for (i = 0; i < 64; ++i)
+    {
+        pattern[i] = 0x70 + i;
+        line[i] = 0x0f ^ i;
+    }
+    dram_backdoor_write(dram_id, 0x300000, pattern, 64);
+    char * path = write_file("image.bin", "");
+    dram_dump_image(dram_id, path, 0x400000);
+    CHECK(stat(path, &st) == 0 && st.st_size == 0x400000 && st.st_blocks * 512 < 0x100000,
+        "image of %lld bytes, %lld allocated", (long long)st.st_size, (long long)st.st_blocks * 512);
+
+    dram_load_image(image_id, path);
+    CHECK(dram_hash_range(image_id, 0, 0x400000) == dram_hash_range(dram_id, 0, 0x400000), "loaded image differs from the dumped DRAM");
+    CHECK(dram_channel_pointers(image_id, pointers, sizes, 1) == 1 && mapping_is_file(pointers[0], path), "image not mapped over the storage");
+    blocking_access(image_id, 0x300000, 0, data);
+    CHECK(memcmp(data, pattern, 64) == 0, "read request of the image contents");
+
+    blocking_access(image_id, 0x300000, 1, line);
+    dram_backdoor_read(image_id, 0x300000, data, 64);
+    CHECK(memcmp(data, line, 64) == 0, "write request to the image not seen by the backdoor");
+    FILE * file = fopen(path, "rb");
+    CHECK(file != NULL && fseek(file, 0x300000, SEEK_SET) == 0 && fread(data, 1, 64, file) == 64 && memcmp(data, pattern, 64) == 0,
+        "write request reached the image file");
+    if (file != NULL) fclose(file);
+    unlink(path);
+}
+
+// Reads len bytes of a file at offset, returns 0 on error
+int read_file_at(const char * path, long offset, uint8_t * data, size_t len) {
+    FILE * file = fopen(path, "rb");
+    int ok = file != NULL && fseek(file, offset, SEEK_SET) == 0 && fread(data, 1, len, file) == len;
+    if (file != NULL) fclose(file);
+    return ok;
+}
+
+// The segments of an ELF file loaded at its base address are seen by read requests, .bss included,
+// and the entry point and symbols of the file are kept. On a memory system, the segments are split
+// over the instances by the address decoding.
+void test_elf(int dram_id) {
+    uint8_t data[64], golden[64], fill[64], zeros[64] = {0};
+    uint64_t offsets[] = {0x840, 0x8000, 0x8a40, 0xb200};
+    uint64_t value = 0;
+    unsigned i;
+    memset(fill, 0xff, 64);
+    dram_backdoor_write(dram_id, 0x1540, fill, 64);
+    dram_load_elf(dram_id, ELF_BASE, ELF_PATH);
+
+    CHECK(dram_elf_entry() == 0x1c008080, "entry 0x%llx", (unsigned long long)dram_elf_entry());
+    CHECK(dram_elf_symbol("main", &value) && value == 0x1c008a68, "main at 0x%llx", (unsigned long long)value);
+    CHECK(!dram_elf_symbol("no_such_symbol", &value), "unknown symbol found");
+    for (i = 0; i < sizeof(offsets) / sizeof(offsets[0]); ++i)
+    {
+        blocking_access(dram_id, offsets[i], 0, data);
+        CHECK(read_file_at(ELF_PATH, offsets[i] < 0x8000 ? offsets[i] + 0x1000 : offsets[i] - 0x5000, golden, 64) && memcmp(data, golden, 64) == 0,
+            "read request at 0x%llx differs from the ELF file", (unsigned long long)offsets[i]);
+    }
+    blocking_access(dram_id, 0x1540, 0, data);
+    CHECK(memcmp(data, zeros, 64) == 0, ".bss not zeroed");
+}
+
+// Backdoor accesses of the 4-channel wideio-example.json are decoded to the storage of each channel:
+// a range across a channel boundary reads back whole and is seen by read requests, and the region of
+// each channel in dram_channel_pointers holds the lines of that channel only
+void test_backdoor_channels(int dram_id) {
+    unsigned char * pointers[8];
+    uint64_t sizes[8];
+    uint8_t range[8192], data[8192], line[4][64];
+    int nb_regions = dram_channel_pointers(dram_id, pointers, sizes, 8), c, r, i;
+    CHECK(nb_regions == 4, "%d storage regions", nb_regions);
+    for (r = 0; r < nb_regions && r < 4; ++r) CHECK(sizes[r] == 0x2000000, "region %d of %llu bytes", r, (unsigned long long)sizes[r]);
+
+    for (i = 0; i < (int)sizeof(range); ++i) range[i] = i * 13 + 7;
+    dram_backdoor_write(dram_id, 0x2000000 - 4096, range, sizeof(range));
+    dram_backdoor_read(dram_id, 0x2000000 - 4096, data, sizeof(data));
+    CHECK(memcmp(data, range, sizeof(range)) == 0, "range across the first channel boundary");
+    CHECK(dram_decode_channel(dram_id, 0x2000000 - 1) == 0 && dram_decode_channel(dram_id, 0x2000000) == 1, "channel decoding at the boundary");
+    blocking_access(dram_id, 0x2000000 - 64, 0, data);
+    CHECK(memcmp(data, range + 4096 - 64, 64) == 0, "read request of the last line of channel 0");
+    blocking_access(dram_id, 0x2000000, 0, data);
+    CHECK(memcmp(data, range + 4096, 64) == 0, "read request of the first line of channel 1");
+
+    for (c = 0; c < 4; ++c)
+    {
+        memset(line[c], 0, 64);
+        snprintf((char *)line[c], 64, "line of channel %d written through the decoded backdoor", c);
+        dram_backdoor_write(dram_id, (uint64_t)c * 0x2000000 + 0x12340, line[c], 64);
+    }
+    for (c = 0; c < 4; ++c)
+    {
+        for (r = 0; r < nb_regions && r < 4; ++r)
+        {
+            int found = memmem(pointers[r], sizes[r], line[c], 64) != NULL;
+            CHECK(found == (r == c), "line of channel %d %s region %d", c, found ? "found in" : "missing from", r);
+        }
+    }
+}
+
+// Loading the same configuration files again gives the handle of the parsed configuration, other
+// files give another one, and a DRAM added from the handle is the one add_dram gives for the files
+void test_config(int handle, int dram_id, GvsocMemspec * memspec, GvsocMemspec * add_dram_memspec) {
+    uint8_t line[64], data[64];
+    int i;
+    CHECK(dram_config_load(CONFIG_DIR, HBM2_CONFIG) == handle, "configuration parsed twice");
+    CHECK(dram_config_load(CONFIG_DIR, WIDEIO_CONFIG) != handle, "other files share the handle");
+    CHECK(memcmp(memspec, add_dram_memspec, sizeof(GvsocMemspec)) == 0, "memspec differs from the one of add_dram");
+
+    for (i = 0; i < 64; ++i) line[i] = 0x99 ^ i;
+    blocking_access(dram_id, 0xc0000, 1, line);
+    blocking_access(dram_id, 0xc0000, 0, data);
+    CHECK(memcmp(data, line, 64) == 0, "DRAM added from a handle does not keep its data");
+}
+
+// Row hits, misses and conflicts of the analytical backend on one bank, far from the first refresh at
+// tREFI = 3.9 us. The latencies differ by tRCDRD and tRP of memspec/HBM2.json, 12 and 14 cycles of 1 ns.
+void test_analytical(int dram_id, GvsocMemspec * memspec) {
+    uint8_t pattern[64], data[64];
+    int i;
+    CHECK(memspec->row_stride == 0x10000, "row stride 0x%x", memspec->row_stride);
+    for (i = 0; i < 64; ++i) pattern[i] = i * 5 + 1;
+    dram_backdoor_write(dram_id, 0x100000, pattern, 64);
+
+    uint64_t miss = blocking_access(dram_id, 0x100000, 0, data);
+    CHECK(memcmp(data, pattern, 64) == 0, "read data");
+    uint64_t hit = blocking_access(dram_id, 0x100000, 0, data);
+    uint64_t conflict = blocking_access(dram_id, 0x100000 + memspec->row_stride, 0, data);
+    CHECK(hit < miss && miss < conflict, "hit %llu ps, miss %llu ps, conflict %llu ps",
+        (unsigned long long)hit, (unsigned long long)miss, (unsigned long long)conflict);
+    CHECK(miss - hit == 12000 && conflict - miss == 14000, "miss %llu ps after a hit, conflict %llu ps after a miss",
+        (unsigned long long)(miss - hit), (unsigned long long)(conflict - miss));
+}
+
+// Counters of 4 requests on bank 0 of am_hbm2_16Gb-8H_pc_brc.json, whose open page policy keeps the row
+// of the previous access: a miss, a hit in the next column, a write conflicting in the next row and a
+// hit in that row. Every response lands in the latency histograms and in the bandwidth windows of 1000
+// cycles of 1 ns set by simconfig/example.json, and the JSON dump reports the same counters.
+void test_stats(int dram_id) {
+    static const uint64_t expected[DRAM_STATS_NB_COUNTERS] = {3, 1, 192, 64, 2, 1, 1};
+    uint64_t values[DRAM_STATS_NB_COUNTERS], buckets[DRAM_STATS_NB_BUCKETS], read_bytes[64], write_bytes[64], window_ps, sum;
+    uint8_t data[64];
+    unsigned nb_channels, nb_banks;
+    char path[256], text[4096];
+    int i, nb_windows, service;
+
+    CHECK(dram_stats_geometry(dram_id, &nb_channels, &nb_banks) == 1 && nb_channels == 1 && nb_banks == 64,
+        "statistics of %u channels of %u banks", nb_channels, nb_banks);
+    dram_stats_reset(dram_id);
+    memset(data, 0x3c, sizeof(data));
+    blocking_access(dram_id, 0x200000, 0, data);
+    blocking_access(dram_id, 0x200800, 0, data);
+    blocking_access(dram_id, 0x210000, 1, data);
+    blocking_access(dram_id, 0x210800, 0, data);
+
+    dram_stats_counters(dram_id, -1, -1, values);
+    for (i = 0; i < DRAM_STATS_NB_COUNTERS; ++i) CHECK(values[i] == expected[i], "DRAM counter %d is %llu", i, (unsigned long long)values[i]);
+    dram_stats_counters(dram_id, 0, 0, values);
+    for (i = 0; i < DRAM_STATS_NB_COUNTERS; ++i) CHECK(values[i] == expected[i], "bank 0 counter %d is %llu", i, (unsigned long long)values[i]);
+    for (service = 0; service < 2; ++service)
+    {
+        CHECK(dram_stats_latency(dram_id, service, buckets) == DRAM_STATS_NB_BUCKETS, "latency buckets");
+        for (sum = 0, i = 0; i < DRAM_STATS_NB_BUCKETS; ++i) sum += buckets[i];
+        CHECK(sum == 4, "%llu responses in the %s histogram", (unsigned long long)sum, service ? "service" : "queueing");
+    }
+    nb_windows = dram_stats_bandwidth(dram_id, read_bytes, write_bytes, 64, &window_ps);
+    CHECK(window_ps == 1000000 && nb_windows > 0 && nb_windows <= 64, "%d bandwidth windows of %llu ps", nb_windows, (unsigned long long)window_ps);
+    uint64_t read_sum = 0, write_sum = 0;
+    for (i = 0; i < nb_windows && i < 64; ++i) read_sum += read_bytes[i], write_sum += write_bytes[i];
+    CHECK(read_sum == 192 && write_sum == 64, "bandwidth windows hold %llu bytes read, %llu written",
+        (unsigned long long)read_sum, (unsigned long long)write_sum);
+
+    snprintf(path, sizeof(path), "%s/stats.json", scratch_dir);
+    CHECK(dram_stats_dump(dram_id, path) == 0, "statistics not dumped");
+    FILE * file = fopen(path, "r");
+    size_t size = file ? fread(text, 1, sizeof(text) - 1, file) : 0;
+    text[size] = 0;
+    if (file) fclose(file);
+    unlink(path);
+    CHECK(strstr(text, "\"reads\": 3, \"writes\": 1, \"read_bytes\": 192, \"write_bytes\": 64, \"row_hits\": 2, \"row_misses\": 1, \"row_conflicts\": 1") != NULL
+        && strstr(text, "\"responses\": 4") != NULL, "statistics dump:\n%s", text);
+    snprintf(path, sizeof(path), "%s/no_such_dir/stats.json", scratch_dir);
+    CHECK(dram_stats_dump(dram_id, path) == -1, "dump to a missing directory not reported");
+
+    dram_stats_reset(dram_id);
+    dram_stats_counters(dram_id, -1, -1, values);
+    for (sum = 0, i = 0; i < DRAM_STATS_NB_COUNTERS; ++i) sum += values[i];
+    CHECK(sum == 0, "counters not cleared by the reset");
+}
+
+// Runs a report function of the library with stdout redirected to the scratch directory, returns its text
+char * capture_report(void (*report)(int), int dram_id) {
+    static char text[4096];
+    snprintf(scratch_path, sizeof(scratch_path), "%s/report.txt", scratch_dir);
+    fflush(stdout);
+    int saved = dup(1);
+    int fd = open(scratch_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    dup2(fd, 1);
+    close(fd);
+    report(dram_id);
+    fflush(stdout);
+    dup2(saved, 1);
+    close(saved);
+    FILE * file = fopen(scratch_path, "r");
+    size_t size = fread(text, 1, sizeof(text) - 1, file);
+    text[size] = 0;
+    fclose(file);
+    unlink(scratch_path);
+    return text;
+}
+
+// dram_profile_report covers the whole library, in the shape of the per-DRAM reports
+void profile_report(int dram_id) {
+    (void)dram_id;
+    dram_profile_report();
+}
+
+// Calls of an entry point in the host profile, -1 when it has no line
+long long profile_calls(const char * name) {
+    char * report = capture_report(profile_report, 0);
+    char line[64];
+    long long calls;
+    snprintf(line, sizeof(line), "\n  %s ", name);
+    char * found = strstr(report, line);
+    if (found == NULL || sscanf(found + strlen(line), "%lld", &calls) != 1) return -1;
+    return calls;
+}
+
+// Transaction log of DRAMSYS_RECORD: a write then a read are written by the writer thread once the
+// DRAM is closed, after the header, in response order and with the times of their path to the controller
+void test_record(int dram_id) {
+    uint8_t data[64];
+    char path[256];
+    DramRecordHeader header;
+    DramRecord records[3];
+    int i;
+    memset(data, 0x5d, sizeof(data));
+    blocking_access(dram_id, 0xe0000, 1, data);
+    blocking_access(dram_id, 0xe0040, 0, data);
+    close_dram(dram_id);
+
+    snprintf(path, sizeof(path), "%s/log%d.bin", scratch_dir, dram_id);
+    FILE * file = fopen(path, "rb");
+    CHECK(file != NULL, "no transaction log in %s", path);
+    if (file == NULL) return;
+    CHECK(fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, "DRAMRLOG", 8) == 0 && header.version == 1
+        && header.record_size == sizeof(DramRecord) && header.dram_id == dram_id, "transaction log header");
+    size_t nb_records = fread(records, sizeof(DramRecord), 3, file);
+    fclose(file);
+    unlink(path);
+    CHECK(nb_records == 2, "%zu transactions logged", nb_records);
+    if (nb_records != 2) return;
+    CHECK(records[0].addr == 0xe0000 && records[0].is_write && records[0].length == 64, "first transaction logged as 0x%llx",
+        (unsigned long long)records[0].addr);
+    CHECK(records[1].addr == 0xe0040 && !records[1].is_write && records[1].length == 64, "second transaction logged as 0x%llx",
+        (unsigned long long)records[1].addr);
+    for (i = 0; i < 2; ++i)
+    {
+        CHECK(records[i].arrival_ps <= records[i].begin_req_ps && records[i].begin_req_ps <= records[i].end_req_ps
+            && records[i].end_req_ps < records[i].begin_resp_ps, "transaction %d times out of order", i);
+    }
+    CHECK(records[0].begin_resp_ps <= records[1].arrival_ps, "read logged before the write was answered");
+}
+
+// Chrome trace of DRAMSYS_TRACE for a read on bank 0 and a write on bank 1 of am_hbm2_16Gb-8H_pc_brc.json
+// (BANK_BIT 8): the bridge and the channel are processes, each bank a track of 256 lanes, the in flight
+// and bandwidth counters are written, and the file is complete once the DRAM is closed
+void test_trace(int dram_id) {
+    static const char header[] = "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    static char text[16384];
+    uint8_t data[64];
+    char path[256], expected[256];
+    size_t size, i;
+    int braces = 0, brackets = 0;
+    memset(data, 0x2b, sizeof(data));
+    blocking_access(dram_id, 0xf0000, 0, data);
+    blocking_access(dram_id, 0xf0100, 1, data);
+    close_dram(dram_id);
+
+    snprintf(path, sizeof(path), "%s/trace%d.json", scratch_dir, dram_id);
+    FILE * file = fopen(path, "r");
+    CHECK(file != NULL, "no trace in %s", path);
+    if (file == NULL) return;
+    size = fread(text, 1, sizeof(text) - 1, file);
+    text[size] = 0;
+    fclose(file);
+    unlink(path);
+    CHECK(strncmp(text, header, sizeof(header) - 1) == 0 && size > 4 && strcmp(text + size - 4, "\n]}\n") == 0,
+        "trace not a complete JSON object:\n%s", text);
+    for (i = 0; i < size; ++i)
+    {
+        braces += (text[i] == '{') - (text[i] == '}');
+        brackets += (text[i] == '[') - (text[i] == ']');
+    }
+    CHECK(braces == 0 && brackets == 0, "trace has unbalanced braces or brackets");
+    snprintf(expected, sizeof(expected), "\"args\": {\"name\": \"DRAM %d bridge\"}", dram_id);
+    CHECK(strstr(text, expected) != NULL, "no bridge process in the trace");
+    snprintf(expected, sizeof(expected), "\"pid\": 1, \"args\": {\"name\": \"DRAM %d channel 0\"}", dram_id);
+    CHECK(strstr(text, expected) != NULL, "no channel process in the trace");
+    CHECK(strstr(text, "\"name\": \"thread_name\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"bank 0\"}") != NULL
+        && strstr(text, "\"name\": \"thread_name\", \"pid\": 1, \"tid\": 256, \"args\": {\"name\": \"bank 1\"}") != NULL, "bank tracks:\n%s", text);
+    char * read_slice = strstr(text, "{\"ph\": \"X\", \"name\": \"read\", \"pid\": 1, \"tid\": 0, ");
+    char * read_args = read_slice ? strstr(read_slice, "\"args\": {\"addr\": \"0xf0000\", \"length\": 64,") : NULL;
+    CHECK(read_args != NULL && read_args < strchr(read_slice, '}'), "read slice on bank 0:\n%s", text);
+    char * write_slice = strstr(text, "{\"ph\": \"X\", \"name\": \"write\", \"pid\": 1, \"tid\": 256, ");
+    char * write_args = write_slice ? strstr(write_slice, "\"args\": {\"addr\": \"0xf0100\", \"length\": 64,") : NULL;
+    CHECK(write_args != NULL && write_args < strchr(write_slice, '}'), "write slice on bank 1:\n%s", text);
+    CHECK(strstr(text, "\"ph\": \"C\", \"name\": \"in flight\", \"pid\": 0,") != NULL
+        && strstr(text, "\"ph\": \"C\", \"name\": \"GB/s\", \"pid\": 1,") != NULL, "counters missing from the trace");
+}
+
+// Host profile enabled by main with DRAMSYS_PROFILE=1: each call of an instrumented entry point is
+// counted once in its line of the report
+void test_profile(int dram_id) {
+    uint8_t data[64];
+    int i;
+    char * report = capture_report(profile_report, 0);
+    CHECK(strstr(report, "DRAMSys bridge host profile:") != NULL && strstr(report, "SystemC delta cycles: ") != NULL,
+        "host profile:\n%s", report);
+    long long before = profile_calls("dram_send_req");
+    memset(data, 0x7e, sizeof(data));
+    for (i = 0; i < 3; ++i) blocking_access(dram_id, 0xd0000 + 64 * i, i == 1, data);
+    long long after = profile_calls("dram_send_req");
+    CHECK(before > 0 && after == before + 3, "dram_send_req profiled %lld calls, then %lld", before, after);
+    CHECK(profile_calls("run_ns") > 0, "run_ns missing from the host profile");
+}
+
+// Sampling of 2 fast-forward, 1 warm-up and 2 measured requests: 10 requests make two measured windows
+// of 2 requests, and data stays coherent between the functional and the DRAMSys path
+void test_sampling(int dram_id) {
+    uint8_t pattern[5][64], data[64];
+    int i, k;
+    dram_enable_sampling(dram_id, 2, 1, 2);
+    for (k = 0; k < 5; ++k)
+    {
+        for (i = 0; i < 64; ++i) pattern[k][i] = k * 64 + i;
+        blocking_access(dram_id, 0x60000 + 0x1000 * k, 1, pattern[k]);
+    }
+    // read back in the reverse order, data written by each path is read by the other one
+    for (k = 4; k >= 0; --k)
+    {
+        blocking_access(dram_id, 0x60000 + 0x1000 * k, 0, data);
+        CHECK(memcmp(data, pattern[k], 64) == 0, "request %d read back wrong data", k);
+        dram_backdoor_read(dram_id, 0x60000 + 0x1000 * k, data, 64);
+        CHECK(memcmp(data, pattern[k], 64) == 0, "request %d not in the DRAMSys storage", k);
+    }
+    char * report = capture_report(dram_sampling_report, dram_id);
+    CHECK(strstr(report, "sampled windows: 2, sampled requests: 4 / 10") != NULL, "sampling report:\n%s", report);
+}
+
+// Functional mode completes requests after the functional latency, writes to the ROI address switch to
+// DRAMSys timing and back without reaching the memory, and the timed region is reported
+void test_roi(int dram_id) {
+    uint8_t pattern[64], marker[64], fill[64], data[64];
+    uint64_t latency;
+    int i;
+    for (i = 0; i < 64; ++i)
+    {
+        pattern[i] = 0xc0 ^ i;
+        marker[i] = 0xee;
+        fill[i] = 0x11;
+    }
+    dram_backdoor_write(dram_id, 0x70000, pattern, 64);
+    dram_backdoor_write(dram_id, 0x7f000, fill, 64);
+    dram_set_roi_addr(dram_id, 0x7f000);
+    dram_set_functional(dram_id, 1);
+
+    latency = blocking_access(dram_id, 0x70000, 0, data);
+    CHECK(latency <= 1000, "functional read took %llu ps", (unsigned long long)latency);
+    CHECK(memcmp(data, pattern, 64) == 0, "functional read data");
+    dram_set_functional_latency(dram_id, 5000);
+    latency = blocking_access(dram_id, 0x70000, 0, data);
+    CHECK(latency >= 5000 && latency <= 6000, "functional read with a 5 ns latency took %llu ps", (unsigned long long)latency);
+    dram_set_functional_latency(dram_id, 0);
+
+    blocking_access(dram_id, 0x7f000, 1, marker);
+    dram_backdoor_read(dram_id, 0x7f000, data, 64);
+    CHECK(memcmp(data, fill, 64) == 0, "ROI marker written to the memory");
+    for (i = 0; i < 2; ++i)
+    {
+        latency = blocking_access(dram_id, 0x70000, 0, data);
+        CHECK(latency > 10000, "timed read took %llu ps", (unsigned long long)latency);
+        CHECK(memcmp(data, pattern, 64) == 0, "timed read data");
+    }
+    char * report = capture_report(dram_roi_report, dram_id);
+    CHECK(strstr(report, "requests: 2, bytes: 128") != NULL, "ROI report:\n%s", report);
+
+    blocking_access(dram_id, 0x7f000, 1, marker);
+    latency = blocking_access(dram_id, 0x70000, 0, data);
+    CHECK(latency <= 1000, "read after the second ROI marker took %llu ps", (unsigned long long)latency);
+}
+
+// Requests sent to a DRAM added with DRAMSYS_CAPTURE are read back from its capture with the parser
+// of dramsys_sweep, in order and after the first run_ns at the default 1000 MHz capture clock
+void test_capture(int dram_id) {
+    uint8_t data[64];
+    int sent = 0, answered = 0, parsed = 0, i;
+    uint64_t cycle, length, addr, last_cycle = 0;
+    int is_write;
+    for (i = 0; (sent < 8 || answered < sent) && i < 10000; ++i)
+    {
+        if (sent < 8 && dram_can_accept_req(dram_id))
+        {
+            dram_send_req(dram_id, 0x1000 * sent + 0x40, 64, sent & 1, 0);
+            sent++;
+        }
+        run_ns(100);
+        if (dram_has_read_rsp(dram_id))
+        {
+            dram_get_read_rsp(dram_id, 64, data);
+            answered++;
+        }
+        while (dram_has_write_rsp(dram_id))
+        {
+            dram_get_write_rsp(dram_id);
+            answered++;
+        }
+    }
+    CHECK(sent == 8 && answered == 8, "%d requests sent, %d answered", sent, answered);
+    close_dram(dram_id);
+
+    char path[256];
+    char line[256];
+    snprintf(path, sizeof(path), "%s/capture%d.stl", scratch_dir, dram_id);
+    FILE * file = fopen(path, "r");
+    CHECK(file != NULL, "no capture in %s", path);
+    while (file && fgets(line, sizeof(line), file))
+    {
+        line[strcspn(line, "\n")] = 0;
+        int result = dram_capture_parse_line(line, 32, &cycle, &length, &is_write, &addr);
+        CHECK(result >= 0, "malformed capture line: %s", line);
+        if (result <= 0) continue;
+        CHECK(addr == 0x1000 * (uint64_t)parsed + 0x40 && length == 64 && is_write == (parsed & 1), "request %d captured as %s", parsed, line);
+        CHECK(cycle >= 1000 && cycle >= last_cycle, "request %d captured at cycle %llu", parsed, (unsigned long long)cycle);
+        last_cycle = cycle;
+        parsed++;
+    }
+    CHECK(parsed == sent, "%d of %d requests captured", parsed, sent);
+    if (file) fclose(file);
+    unlink(path);
+
+    CHECK(dram_capture_parse_line("12: read 0x80", 32, &cycle, &length, &is_write, &addr) == 1 &&
+          cycle == 12 && length == 32 && !is_write && addr == 0x80, "request without length");
+    CHECK(dram_capture_parse_line("# cycle: (length) command hex-address", 32, &cycle, &length, &is_write, &addr) == 0, "comment");
+    CHECK(dram_capture_parse_line("12: (64) fetch 0x80", 32, &cycle, &length, &is_write, &addr) == -1, "unknown command");
+    CHECK(dram_capture_parse_line("12 (64) read 0x80", 32, &cycle, &length, &is_write, &addr) == -1, "missing colon");
+}
+
+// The SystemC thread serves four times the ring size in order, completions never run ahead of the
+// quantum granted by the barrier, and the DRAM answers polled requests again once the thread is stopped.
+// Every DRAM is driven by the thread from dram_start_thread on, so this test runs last.
+void test_thread(int dram_id) {
+    uint8_t data[64];
+    uint64_t tag, is_write, time_ps;
+    int posted = 0, polled = 0, i, k;
+    for (k = 0; k < 256; ++k)
+    {
+        memset(data, k, 64);
+        dram_backdoor_write(dram_id, 0x90000 + 64 * k, data, 64);
+    }
+    uint64_t start = dram_get_time_ps();
+    uint64_t quantum = start;
+    dram_start_thread();
+    while (posted < 256 && dram_post_req(dram_id, posted, 0x90000 + 64 * posted, 64, 0, 0, NULL, NULL, start + 1000 * posted)) posted++;
+    CHECK(posted == 64, "request ring full after %d requests", posted);
+    for (i = 0; polled < 256 && i < 10000; ++i)
+    {
+        while (posted < 256 && dram_post_req(dram_id, posted, 0x90000 + 64 * posted, 64, 0, 0, NULL, NULL, start + 1000 * posted)) posted++;
+        quantum += 10000;
+        dram_quantum_barrier(quantum);
+        while (dram_poll_rsp(dram_id, &tag, &is_write, data, &time_ps))
+        {
+            CHECK(tag == (uint64_t)polled && !is_write, "completion %d has tag %llu", polled, (unsigned long long)tag);
+            for (k = 0; k < 64 && data[k] == (uint8_t)tag; ++k);
+            CHECK(k == 64, "completion %llu data", (unsigned long long)tag);
+            CHECK(time_ps > start + 1000 * tag && time_ps <= quantum, "completion %llu at %llu ps, quantum ends at %llu ps",
+                (unsigned long long)tag, (unsigned long long)(time_ps - start), (unsigned long long)(quantum - start));
+            polled++;
+        }
+    }
+    CHECK(polled == 256, "%d of 256 requests completed", polled);
+    dram_stop_thread();
+
+    blocking_access(dram_id, 0x90000 + 64 * 7, 0, data);
+    for (k = 0; k < 64 && data[k] == 7; ++k);
+    CHECK(k == 64, "polled read after dram_stop_thread");
+}
+
+// Forks a server of the library on a new shared memory segment, named in name
+pid_t start_server(char * name, size_t size, int index) {
+    snprintf(name, size, "/dramsys_tests%d_%d", (int)getpid(), index);
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) _exit(dram_serve(name));
+    return pid;
+}
+
+// Sends a request through the client library and waits for its response
+void client_access(int dram_id, uint64_t addr, int is_write, uint8_t * data) {
+    int i;
+    for (i = 0; is_write && i < 64; ++i) client.dram_write_buffer(dram_id, data[i], i);
+    client.dram_send_req(dram_id, addr, 64, is_write, 0);
+    for (i = 0; (is_write ? !client.dram_has_write_rsp(dram_id) : client.dram_has_read_rsp(dram_id) < 64) && i < 10000; ++i) client.run_ns(10);
+    if (is_write) client.dram_get_write_rsp(dram_id);
+    else client.dram_get_read_rsp(dram_id, 64, data);
+}
+
+// A DRAM of the forked servers driven through the client library: backdoor contents hash like in the
+// library of this process and requests are answered through the shared memory
+void test_server(int id, GvsocMemspec * memspec, int dram_id) {
+    uint8_t pattern[4000], line[64], data[64];
+    int i;
+    CHECK(memspec->access_size == 32 && memspec->row_stride == 0x10000, "server memspec: access size %u, row stride 0x%x",
+        memspec->access_size, memspec->row_stride);
+
+    for (i = 0; i < (int)sizeof(pattern); ++i) pattern[i] = i * 11 + 5;
+    client.dram_backdoor_write(id, 0xa0000 - 7, pattern, sizeof(pattern));
+    dram_backdoor_write(dram_id, 0xa0000 - 7, pattern, sizeof(pattern));
+    CHECK(client.dram_hash_range(id, 0xa0000 - 7, sizeof(pattern)) == dram_hash_range(dram_id, 0xa0000 - 7, sizeof(pattern)),
+        "hash of the server differs");
+
+    for (i = 0; i < 64; ++i) line[i] = 0x5a ^ i;
+    client_access(id, 0xa0040, 1, line);
+    client.dram_backdoor_read(id, 0xa0040, data, 64);
+    CHECK(memcmp(data, line, 64) == 0, "write request not seen by the backdoor of the server");
+    client_access(id, 0xa0040, 0, data);
+    CHECK(memcmp(data, line, 64) == 0, "read request after the write request");
+    client_access(id, 0xa0080, 0, data);
+    CHECK(memcmp(data, pattern + 0x87, 64) == 0, "read request of backdoor contents");
+
+    unsigned char * pointers[1];
+    uint64_t sizes[1];
+    CHECK(client.dram_channel_pointers(id, pointers, sizes, 1) == 0, "storage of the server exported to the client");
+}
+
+// The 4 channels of wideio-example.json, 32 MB each at address bits 25-26, spread over 2 servers:
+// reads alternating between the channels, hence between the servers, are answered in request order,
+// and backdoor accesses across channel boundaries reach the server of each channel
+void test_channel_parallel(int id, GvsocMemspec * memspec, int dram_id) {
+    uint8_t pattern[8][64], boundary[4096], line[64], data[64];
+    int sent = 0, i, k;
+    CHECK(memspec->nb_channels == 4 && memspec->access_size == 64, "wideio memspec: %u channels, access size %u",
+        memspec->nb_channels, memspec->access_size);
+
+    for (k = 0; k < 8; ++k)
+    {
+        for (i = 0; i < 64; ++i) pattern[k][i] = 16 * k + i;
+        client.dram_backdoor_write(id, (uint64_t)(k % 4) * 0x2000000 + 0x2000 + 64 * k, pattern[k], 64);
+    }
+    for (i = 0; sent < 8 && i < 10000; ++i)
+    {
+        if (client.dram_can_accept_req(id))
+        {
+            client.dram_send_req(id, (uint64_t)(sent % 4) * 0x2000000 + 0x2000 + 64 * sent, 64, 0, 0);
+            sent++;
+        }
+        else client.run_ns(10);
+    }
+    for (i = 0; client.dram_has_read_rsp(id) < 8 * 64 && i < 10000; ++i) client.run_ns(10);
+    CHECK(client.dram_has_read_rsp(id) == 8 * 64, "%d of 512 bytes read across the channels", client.dram_has_read_rsp(id));
+    for (k = 0; k < 8; ++k)
+    {
+        client.dram_get_read_rsp(id, 64, data);
+        CHECK(memcmp(data, pattern[k], 64) == 0, "read %d of channel %d out of order or wrong", k, k % 4);
+    }
+
+    for (i = 0; i < (int)sizeof(boundary); ++i) boundary[i] = i * 7 + 1;
+    for (k = 1; k < 4; ++k)
+    {
+        client.dram_backdoor_write(id, (uint64_t)k * 0x2000000 - 2048, boundary, sizeof(boundary));
+        dram_backdoor_write(dram_id, (uint64_t)k * 0x2000000 - 2048, boundary, sizeof(boundary));
+        CHECK(client.dram_hash_range(id, (uint64_t)k * 0x2000000 - 2048, sizeof(boundary))
+            == dram_hash_range(dram_id, (uint64_t)k * 0x2000000 - 2048, sizeof(boundary)), "hash across the start of channel %d", k);
+    }
+
+    for (i = 0; i < 64; ++i) line[i] = 0xa5 ^ i;
+    client_access(id, 3 * 0x2000000 + 0x4000, 1, line);
+    client.dram_backdoor_read(id, 3 * 0x2000000 + 0x4000, data, 64);
+    CHECK(memcmp(data, line, 64) == 0, "write request of channel 3 not seen by the backdoor");
+}
+
+int main(int argc, char ** argv) {
+    const char * library = argc > 1 ? argv[1] : "third_party/DRAMSys/libDRAMSys_Simulator.so";
+    int i, status;
+
+    // read once, on the first call of an instrumented entry point
+    setenv("DRAMSYS_PROFILE", "1", 1);
+    libraryHandle = dlopen(library, RTLD_LAZY);
+    if (libraryHandle == NULL)
+    {
+        printf("can not load %s: %s\n", library, dlerror());
+        return 1;
+    }
+
+    add_dram = get_function("add_dram");
+    add_dram_backend = get_function("add_dram_backend");
+    dram_config_load = get_function("dram_config_load");
+    add_dram_from_config = get_function("add_dram_from_config");
+    add_dram_ports = get_function("add_dram_ports");
+    add_dram_system = get_function("add_dram_system");
+    close_dram = get_function("close_dram");
+    run_ns = get_function("run_ns");
+    dram_can_accept_req = get_function("dram_can_accept_req");
+    dram_send_req = get_function("dram_send_req");
+    dram_has_read_rsp = get_function("dram_has_read_rsp");
+    dram_get_read_rsp = get_function("dram_get_read_rsp");
+    dram_has_write_rsp = get_function("dram_has_write_rsp");
+    dram_get_write_rsp = get_function("dram_get_write_rsp");
+    dram_backdoor_write = get_function("dram_backdoor_write");
+    dram_backdoor_read = get_function("dram_backdoor_read");
+    dram_hash_range = get_function("dram_hash_range");
+    dram_compare_range = get_function("dram_compare_range");
+    dram_load_file = get_function("dram_load_file");
+    dram_channel_pointers = get_function("dram_channel_pointers");
+    dram_decode_channel = get_function("dram_decode_channel");
+    dram_checkpoint = get_function("dram_checkpoint");
+    dram_restore = get_function("dram_restore");
+    dram_capture_parse_line = get_function("dram_capture_parse_line");
+    dram_load_elf = get_function("dram_load_elf");
+    dram_elf_symbol = get_function("dram_elf_symbol");
+    dram_elf_entry = get_function("dram_elf_entry");
+    dram_dump_image = get_function("dram_dump_image");
+    dram_load_image = get_function("dram_load_image");
+    dram_storage_reserved = get_function("dram_storage_reserved");
+    dram_storage_resident = get_function("dram_storage_resident");
+    dram_set_timed_window = get_function("dram_set_timed_window");
+    dram_can_accept_timed_req = get_function("dram_can_accept_timed_req");
+    dram_send_req_timed = get_function("dram_send_req_timed");
+    dram_get_timing_error = get_function("dram_get_timing_error");
+    dram_get_time_ps = get_function("dram_get_time_ps");
+    run_until_ps = get_function("run_until_ps");
+    dram_get_inflight_read = get_function("dram_get_inflight_read");
+    dram_write_buffer = get_function("dram_write_buffer");
+    dram_enable_sampling = get_function("dram_enable_sampling");
+    dram_sampling_report = get_function("dram_sampling_report");
+    dram_set_functional = get_function("dram_set_functional");
+    dram_set_functional_latency = get_function("dram_set_functional_latency");
+    dram_set_roi_addr = get_function("dram_set_roi_addr");
+    dram_roi_report = get_function("dram_roi_report");
+    dram_start_thread = get_function("dram_start_thread");
+    dram_post_req = get_function("dram_post_req");
+    dram_poll_rsp = get_function("dram_poll_rsp");
+    dram_quantum_barrier = get_function("dram_quantum_barrier");
+    dram_stop_thread = get_function("dram_stop_thread");
+    dram_serve = get_function("dram_serve");
+    dram_profile_report = get_function("dram_profile_report");
+    dram_stats_geometry = get_function("dram_stats_geometry");
+    dram_stats_counters = get_function("dram_stats_counters");
+    dram_stats_latency = get_function("dram_stats_latency");
+    dram_stats_bandwidth = get_function("dram_stats_bandwidth");
+    dram_stats_reset = get_function("dram_stats_reset");
+    dram_stats_dump = get_function("dram_stats_dump");
+
+    char client_library[256];
+    const char * slash = strrchr(library, '/');
+    if (argc > 2) snprintf(client_library, sizeof(client_library), "%s", argv[2]);
+    else if (slash != NULL) snprintf(client_library, sizeof(client_library), "%.*s/libDRAMSys_Client.so", (int)(slash - library), library);
+    else snprintf(client_library, sizeof(client_library), "./libDRAMSys_Client.so");
+    clientHandle = dlopen(client_library, RTLD_LAZY);
+    if (clientHandle == NULL)
+    {
+        printf("can not load %s: %s\n", client_library, dlerror());
+        return 1;
+    }
+    client.add_dram = get_client_function("add_dram");
+    client.close_dram = get_client_function("close_dram");
+    client.run_ns = get_client_function("run_ns");
+    client.dram_can_accept_req = get_client_function("dram_can_accept_req");
+    client.dram_send_req = get_client_function("dram_send_req");
+    client.dram_write_buffer = get_client_function("dram_write_buffer");
+    client.dram_has_read_rsp = get_client_function("dram_has_read_rsp");
+    client.dram_get_read_rsp = get_client_function("dram_get_read_rsp");
+    client.dram_has_write_rsp = get_client_function("dram_has_write_rsp");
+    client.dram_get_write_rsp = get_client_function("dram_get_write_rsp");
+    client.dram_backdoor_write = get_client_function("dram_backdoor_write");
+    client.dram_backdoor_read = get_client_function("dram_backdoor_read");
+    client.dram_hash_range = get_client_function("dram_hash_range");
+    client.dram_channel_pointers = get_client_function("dram_channel_pointers");
+    client.dram_shutdown_server = get_client_function("dram_shutdown_server");
+
+    if (mkdtemp(scratch_dir) == NULL)
+    {
+        printf("can not create %s\n", scratch_dir);
+        return 1;
+    }
+
+    // the servers are forked before SystemC holds any state, the client library connects on its first add_dram
+    char server_names[2][64], shm_names[130];
+    pid_t servers[2];
+    for (i = 0; i < 2; ++i) servers[i] = start_server(server_names[i], sizeof(server_names[i]), i);
+    snprintf(shm_names, sizeof(shm_names), "%s,%s", server_names[0], server_names[1]);
+    setenv("DRAMSYS_SHM", shm_names, 1);
+    GvsocMemspec server_memspec, channels_memspec;
+    int server_id = client.add_dram(CONFIG_DIR, HBM2_CONFIG, &server_memspec);
+    int channels_id = client.add_dram(CONFIG_DIR, WIDEIO_CONFIG, &channels_memspec);
+
+    int dram_id = add_dram(CONFIG_DIR, HBM2_CONFIG, NULL);
+    int modulo_id = add_dram_system(CONFIG_DIR, HBM2_CONFIG "," HBM2_CONFIG "," HBM2_CONFIG, NULL, 256, 0);
+    int xor_id = add_dram_system(CONFIG_DIR, HBM2_CONFIG "," HBM2_CONFIG, NULL, 512, 1);
+    GvsocMemspec analytical_memspec;
+    int analytical_id = add_dram_backend(CONFIG_DIR, HBM2_CONFIG, &analytical_memspec, DRAM_BACKEND_ANALYTICAL);
+    int ports_id = add_dram_ports(CONFIG_DIR, HBM2_CONFIG, NULL, 2);
+    int sampled_id = add_dram(CONFIG_DIR, HBM2_CONFIG, NULL);
+    int roi_id = add_dram(CONFIG_DIR, HBM2_CONFIG, NULL);
+    GvsocMemspec storage_memspec;
+    int storage_id = add_dram(CONFIG_DIR, HBM2_CONFIG, &storage_memspec);
+    int config_handle = dram_config_load(CONFIG_DIR, HBM2_CONFIG);
+    GvsocMemspec config_memspec;
+    int config_id = add_dram_from_config(config_handle, &config_memspec);
+    // DRAMSys looks for the files of a simulation file next to it, the scratch one names them by absolute path
+    char policy_config[2048], configs[512];
+    if (getcwd(configs, sizeof(configs) - sizeof(CONFIG_DIR) - 1) == NULL) return 1;
+    strcat(configs, "/" CONFIG_DIR);
+    write_file("policy_simconfig.json", "{\"simconfig\": {\"StoreMode\": \"Store\", \"UseMalloc\": false, \"DatabaseRecording\": false,"
+        " \"StorageHugePages\": \"Transparent\", \"StorageNumaNode\": \"Local\"}}");
+    snprintf(policy_config, sizeof(policy_config), "{\"simulation\": {\"addressmapping\": \"%s/addressmapping/am_hbm2_16Gb-8H_pc_brc.json\","
+        " \"mcconfig\": \"%s/mcconfig/fr_fcfs.json\", \"memspec\": \"%s/memspec/HBM2.json\", \"simconfig\": \"%s\","
+        " \"simulationid\": \"hbm2-policy\"}}", configs, configs, configs, scratch_path);
+    snprintf(policy_config, sizeof(policy_config), "%s", write_file("policy.json", policy_config));
+    int policy_id = add_dram(CONFIG_DIR, policy_config, NULL);
+    int image_id = add_dram(CONFIG_DIR, HBM2_CONFIG, NULL);
+    int elf_id = add_dram(CONFIG_DIR, HBM2_CONFIG, NULL);
+    int wideio_id = add_dram(CONFIG_DIR, WIDEIO_CONFIG, NULL);
+    int thread_id = add_dram(CONFIG_DIR, HBM2_CONFIG, NULL);
+    int stats_id = add_dram(CONFIG_DIR, HBM2_CONFIG, NULL);
+    char capture_prefix[256];
+    snprintf(capture_prefix, sizeof(capture_prefix), "%s/capture", scratch_dir);
+    setenv("DRAMSYS_CAPTURE", capture_prefix, 1);
+    int capture_id = add_dram(CONFIG_DIR, HBM2_CONFIG, NULL);
+    unsetenv("DRAMSYS_CAPTURE");
+    char record_prefix[256];
+    snprintf(record_prefix, sizeof(record_prefix), "%s/log", scratch_dir);
+    setenv("DRAMSYS_RECORD", record_prefix, 1);
+    int record_id = add_dram(CONFIG_DIR, HBM2_CONFIG, NULL);
+    unsetenv("DRAMSYS_RECORD");
+    char trace_prefix[256];
+    snprintf(trace_prefix, sizeof(trace_prefix), "%s/trace", scratch_dir);
+    setenv("DRAMSYS_TRACE", trace_prefix, 1);
+    int trace_id = add_dram(CONFIG_DIR, HBM2_CONFIG, NULL);
+    unsetenv("DRAMSYS_TRACE");
+    run_ns(1000);
+
+    test_hash(dram_id);
+    test_load_file(dram_id);
+    test_system(modulo_id, 3, 256, 0);
+    test_system(xor_id, 2, 512, 1);
+    test_checkpoint(dram_id);
+    test_storage_footprint(storage_id, &storage_memspec);
+    test_storage_policy(policy_id, storage_id);
+    test_config(config_handle, config_id, &config_memspec, &storage_memspec);
+    test_timed(dram_id);
+    test_image(dram_id, image_id);
+    test_elf(elf_id);
+    test_elf(modulo_id);
+    test_backdoor_channels(wideio_id);
+    test_analytical(analytical_id, &analytical_memspec);
+    test_ports(ports_id, sampled_id);
+    test_sampling(sampled_id);
+    test_roi(roi_id);
+    test_server(server_id, &server_memspec, dram_id);
+    test_channel_parallel(channels_id, &channels_memspec, dram_id);
+    test_capture(capture_id);
+    test_record(record_id);
+    test_trace(trace_id);
+    test_stats(stats_id);
+    test_profile(dram_id);
+    test_thread(thread_id);
+
+    // the SystemC simulation is stopped with the first DRAM
+    char stats_prefix[128];
+    snprintf(stats_prefix, sizeof(stats_prefix), "%s/stats", scratch_dir);
+    setenv("DRAMSYS_STATS", stats_prefix, 1);
+    close_dram(stats_id);
+    unsetenv("DRAMSYS_STATS");
+    snprintf(scratch_path, sizeof(scratch_path), "%s%d.json", stats_prefix, stats_id);
+    CHECK(access(scratch_path, R_OK) == 0, "DRAMSYS_STATS did not write %s on close", scratch_path);
+    unlink(scratch_path);
+    close_dram(xor_id);
+    close_dram(analytical_id);
+    close_dram(ports_id + 1);
+    close_dram(ports_id);
+    close_dram(sampled_id);
+    close_dram(roi_id);
+    close_dram(storage_id);
+    close_dram(policy_id);
+    close_dram(config_id);
+    close_dram(image_id);
+    close_dram(elf_id);
+    close_dram(wideio_id);
+    close_dram(thread_id);
+    close_dram(modulo_id);
+    close_dram(dram_id);
+    client.close_dram(channels_id);
+    client.close_dram(server_id);
+    client.dram_shutdown_server();
+    for (i = 0; i < 2; ++i)
+    {
+        CHECK(waitpid(servers[i], &status, 0) == servers[i] && WIFEXITED(status) && WEXITSTATUS(status) == 0,
+            "server %d exit status 0x%x", i, status);
+    }
+    dlclose(clientHandle);
+    dlclose(libraryHandle);
+    rmdir(scratch_dir);
+
+    printf("%s: %d failures\n", failures ? "DRAMSys tests FAILED" : "DRAMSys tests passed", failures);
+    return failures != 0;
+}